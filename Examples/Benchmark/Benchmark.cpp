@@ -0,0 +1,167 @@
+/*
+
+This file is part of the HANCE engine for cross-platform model inference.
+Copyright (c) 2024 HANCE AS.
+
+You are not allowed to use, distribute or modify this code without
+a written permission from HANCE AS.
+
+*/
+
+// The Benchmark example measures the processing time per STFT hop and the real-time
+// factor of one or more HANCE models. Audio is added one hop at a time, which matches
+// real-time use and makes the fixed per-hop overhead of the engine visible, e.g., for
+// the tiny models where the model computations per hop are small. With the --channels
+// option, each model is measured for several channel counts to show how the cost scales
+// with the number of channels compared to one mono processor per channel.
+#include "HanceEngine.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+// A simple error handler
+void handleError (string errorMessage)
+{
+    cout << errorMessage << endl;
+    exit (-1);
+}
+
+// Processes the given number of seconds of noise, prints the timing statistics per hop and
+// returns the mean processing time per hop in microseconds
+double benchmarkModel (const char* modelFilePath, int numOfChannels, double durationInSeconds)
+{
+    // Create the processor at the sample rate of the model, so that no sample rate conversion
+    // is included in the measurements
+    HanceProcessorHandle processorHandle = hanceCreateProcessor (modelFilePath, numOfChannels, 48000.0);
+    if (processorHandle == nullptr)
+        handleError ("Unable to create the HANCE audio processor.");
+
+    HanceProcessorInfo processorInfo;
+    hanceGetProcessorInfo (processorHandle, &processorInfo);
+    if (processorInfo.sampleRate != 48000.0) {
+        hanceDeleteProcessor (processorHandle);
+        processorHandle = hanceCreateProcessor (modelFilePath, numOfChannels, processorInfo.sampleRate);
+        if (processorHandle == nullptr)
+            handleError ("Unable to create the HANCE audio processor.");
+    }
+
+    int hopSize     = max (1, (int) processorInfo.hopSize);
+    int numOfHops   = max (1, (int) (durationInSeconds * processorInfo.sampleRate / hopSize));
+    int numOfWarmUp = max (1, numOfHops / 10);
+
+    // All buffers are allocated before the measurements start
+    mt19937 randomGenerator (1234);
+    normal_distribution<float> noise (0.f, 0.1f);
+    vector<float> inputBuffer (numOfChannels * hopSize);
+    for (auto& value : inputBuffer)
+        value = noise (randomGenerator);
+
+    vector<float> outputBuffer (numOfChannels * 2 * (processorInfo.blockSize + hopSize));
+    vector<double> hopTimes (numOfHops);
+
+    for (int hopIndex = -numOfWarmUp; hopIndex < numOfHops; hopIndex++) {
+        auto startTime = chrono::steady_clock::now();
+
+        hanceAddAudioInterleaved (processorHandle, inputBuffer.data(), hopSize);
+        int numOfPendingSamples = hanceGetNumOfPendingSamples (processorHandle);
+        while (numOfPendingSamples > 0) {
+            int numOfSamplesToGet = min (numOfPendingSamples, (int) (outputBuffer.size() / numOfChannels));
+            if (!hanceGetAudioInterleaved (processorHandle, outputBuffer.data(), numOfSamplesToGet))
+                handleError ("Unable to get audio from the HANCE audio processor.");
+            numOfPendingSamples -= numOfSamplesToGet;
+        }
+
+        auto endTime = chrono::steady_clock::now();
+        if (hopIndex >= 0)
+            hopTimes[hopIndex] = chrono::duration<double, micro> (endTime - startTime).count();
+    }
+
+    hanceDeleteProcessor (processorHandle);
+
+    double totalTime = 0.0;
+    for (auto hopTime : hopTimes)
+        totalTime += hopTime;
+
+    sort (hopTimes.begin(), hopTimes.end());
+    double medianTime  = hopTimes[numOfHops / 2];
+    double p99Time     = hopTimes[min (numOfHops - 1, (int) (numOfHops * 0.99))];
+    double hopDuration = 1e6 * hopSize / processorInfo.sampleRate;
+
+    cout << modelFilePath << endl;
+    cout << " - channels:          " << numOfChannels << endl;
+    cout << " - hop size:          " << hopSize << " samples (" << hopDuration << " us)" << endl;
+    cout << " - mean per hop:      " << totalTime / numOfHops << " us" << endl;
+    cout << " - median per hop:    " << medianTime << " us" << endl;
+    cout << " - 99th percentile:   " << p99Time << " us" << endl;
+    cout << " - real-time factor:  " << hopDuration * numOfHops / totalTime << "x" << endl << endl;
+
+    return totalTime / numOfHops;
+}
+
+int main (int argc, char* argv[])
+{
+    // Parse the input arguments. The optional --channels=1,2,8 flag sets the channel counts to measure.
+    vector<char*> modelFilePaths;
+    vector<int> channelCounts;
+    for (int argumentIndex = 1; argumentIndex < argc; argumentIndex++) {
+        string argument = argv[argumentIndex];
+        if (argument.compare (0, 11, "--channels=") == 0) {
+            stringstream channelList (argument.substr (11));
+            string channelCount;
+            while (getline (channelList, channelCount, ','))
+                channelCounts.push_back (max (1, atoi (channelCount.c_str())));
+        }
+        else
+            modelFilePaths.push_back (argv[argumentIndex]);
+    }
+
+    if (modelFilePaths.empty()) {
+        cout << "Incorrect number of arguments." << endl
+             << "Usage: Benchmark [model filepath] [more model filepaths (optional)...] [--channels=1,2,8 (optional)]" << endl;
+        return -1;
+    }
+    // A mono processor is always measured first, as it is the reference for the channel scaling
+    channelCounts.erase (remove (channelCounts.begin(), channelCounts.end(), 1), channelCounts.end());
+    channelCounts.insert (channelCounts.begin(), 1);
+
+    const double durationInSeconds  = 10.0;
+
+    vector<char> wrapperNameBuffer (255, '\0');
+    hanceGetVectorArithmeticWrapperName ((char*) wrapperNameBuffer.data(), wrapperNameBuffer.size());
+    cout << "Vector arithmetic wrapper: " << wrapperNameBuffer.data() << endl << endl;
+
+    // Always show floating point values with two decimals
+    cout << fixed << setprecision (2);
+
+    for (auto modelFilePath : modelFilePaths) {
+        vector<double> meanHopTimes;
+        for (auto numOfChannels : channelCounts)
+            meanHopTimes.push_back (benchmarkModel (modelFilePath, numOfChannels, durationInSeconds));
+
+        if (channelCounts.size() < 2)
+            continue;
+
+        // The cost per channel is shown relative to a mono processor, so a value below 1 means that
+        // processing the channels together is cheaper than one mono processor per channel
+        cout << "Channel scaling for " << modelFilePath << ":" << endl;
+        double monoTimePerHop = meanHopTimes[0];
+        for (size_t countIndex = 0; countIndex < channelCounts.size(); countIndex++) {
+            double timePerChannel = meanHopTimes[countIndex] / channelCounts[countIndex];
+            cout << " - " << setw (3) << channelCounts[countIndex] << " channels: " << meanHopTimes[countIndex]
+                 << " us per hop, " << timePerChannel << " us per channel ("
+                 << timePerChannel / monoTimePerHop << "x mono)" << endl;
+        }
+        cout << endl;
+    }
+
+    return 0;
+}
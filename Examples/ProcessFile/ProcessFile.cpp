@@ -17,6 +17,9 @@ a written permission from HANCE AS.
 #include <vector>
 #include <set>
 #include <iomanip>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
 
 using namespace std;
 
@@ -40,20 +43,199 @@ void handleError (string errorMessage)
     exit (-1);
 }
 
+// Here's a set of output busses we'd like to include in the output. Other buses will
+// be muted.
+const set<string> g_outputsToIsolate = { "Dialogue", "Speech", "Processed", "Voice", "Vocals", "Snare" };
+
+// Sets the gain and sensitivity of all output busses and optionally prints the settings
+void configureOutputBusses (HanceProcessorHandle processorHandle, bool printSettings)
+{
+    int numOfOutputBusses = hanceGetNumOfOutputBusses (processorHandle);
+
+    for (int busIndex = 0; busIndex < numOfOutputBusses; busIndex++) {
+        vector<char> nameBuffer (255, '\0');
+        hanceGetOutputBusName (processorHandle, busIndex, (char*) nameBuffer.data(), nameBuffer.size());
+        string outputBusName = nameBuffer.data();
+
+        // Set the gain parameters for this output, 1.0 if bus should be included in output, otherwise 0.0
+        if (g_outputsToIsolate.find (outputBusName) != g_outputsToIsolate.end())
+            hanceSetParameterValue (processorHandle, HANCE_PARAM_BUS_GAINS + busIndex, 1.f);
+        else
+            hanceSetParameterValue (processorHandle, HANCE_PARAM_BUS_GAINS + busIndex, 0.f);
+
+        // Set the sensitivity in percent for this output
+        hanceSetParameterValue (processorHandle, HANCE_PARAM_BUS_SENSITIVITIES + busIndex, 0.f);
+
+        if (printSettings) {
+            // Read back the parameter values for demonstration
+            float gain          = hanceGetParameterValue (processorHandle, HANCE_PARAM_BUS_GAINS + busIndex);
+            float sensitivity   = hanceGetParameterValue (processorHandle, HANCE_PARAM_BUS_SENSITIVITIES + busIndex);
+
+            cout << busIndex << ": " << outputBusName << ", gain = " << gain
+                 << " (linear scaling), sensitivity = " << sensitivity << " (%)" << endl;
+        }
+    }
+}
+
+// Processes a segment of channel interleaved audio with a new processor. The first numOfOutputSamples
+// output samples are aligned with the input, and the first numOfSamplesToSkip of them are omitted. Input
+// beyond numOfOutputSamples is only used as lookahead, and the processing tail is flushed with silence
+// only when the segment input doesn't cover it.
+bool processSegment (const char* modelFilePath, const float* inputAudio, int numOfInputSamples, int numOfOutputSamples,
+                     int numOfChannels, double sampleRate, int numOfSamplesToSkip, float* outputAudio)
+{
+    HanceProcessorHandle processorHandle = hanceCreateProcessor (modelFilePath, numOfChannels, sampleRate);
+    if (processorHandle == nullptr)
+        return false;
+
+    configureOutputBusses (processorHandle, false);
+
+    const int maxNumberOfSamplesInBuffer = 2048;
+    vector<float> silentBuffer (numOfChannels * maxNumberOfSamplesInBuffer, 0.f);
+    vector<float> processedBuffer (numOfChannels * maxNumberOfSamplesInBuffer);
+
+    int numOfSamplesAdded     = 0;
+    int numOfSamplesProcessed = 0;
+    bool success              = true;
+
+    while (success && numOfSamplesProcessed < numOfOutputSamples) {
+        // Add audio from the segment, followed by silence to get the processing tail
+        int numOfSamplesInBuffer = maxNumberOfSamplesInBuffer;
+        if (numOfSamplesAdded < numOfInputSamples) {
+            numOfSamplesInBuffer = min (maxNumberOfSamplesInBuffer, numOfInputSamples - numOfSamplesAdded);
+            hanceAddAudioInterleaved (processorHandle, inputAudio + numOfChannels * numOfSamplesAdded, numOfSamplesInBuffer);
+            numOfSamplesAdded += numOfSamplesInBuffer;
+        }
+        else
+            hanceAddAudioInterleaved (processorHandle, silentBuffer.data(), numOfSamplesInBuffer);
+
+        int numOfPendingSamples = hanceGetNumOfPendingSamples (processorHandle);
+        while (success && numOfPendingSamples > 0 && numOfSamplesProcessed < numOfOutputSamples) {
+            int numOfSamplesToGet = min (numOfPendingSamples, maxNumberOfSamplesInBuffer);
+            success = hanceGetAudioInterleaved (processorHandle, processedBuffer.data(), numOfSamplesToGet);
+
+            // Copy the samples that are part of the segment output
+            for (int sampleIndex = 0; sampleIndex < numOfSamplesToGet; sampleIndex++, numOfSamplesProcessed++) {
+                if (numOfSamplesProcessed >= numOfSamplesToSkip && numOfSamplesProcessed < numOfOutputSamples)
+                    memcpy (outputAudio + numOfChannels * (numOfSamplesProcessed - numOfSamplesToSkip),
+                            processedBuffer.data() + numOfChannels * sampleIndex, numOfChannels * sizeof (float));
+            }
+            numOfPendingSamples -= numOfSamplesToGet;
+        }
+    }
+
+    hanceDeleteProcessor (processorHandle);
+    return success;
+}
+
+// Processes the full input file in overlapping segments on separate threads and writes the
+// crossfaded result to the output file. Every segment except the first starts early by a
+// warm-up overlap, so that the model state has settled before its output is used, and every
+// segment except the last reads past its end by the lookahead the model needs. The warm-up
+// overlap is the lookahead plus warmUpInSeconds; models with recurrent state may need a longer one.
+// The whole file is held in memory, and the input, the segment outputs and the joined output
+// amount to about three 32-bit floating point copies of it.
+void processInParallel (const char* modelFilePath, int numOfSamplesInSource, int numOfChannels,
+                        double sampleRate, const HanceProcessorInfo& processorInfo, int numOfJobs,
+                        double warmUpInSeconds)
+{
+    // We read the full input file in the 32-bit floating point format
+    vector<float> inputAudio (numOfChannels * numOfSamplesInSource);
+    if (!readRiffAudio (g_inputFileHandle, inputAudio.data(), (int) inputAudio.size()))
+        handleError ("Unable to read audio from file.");
+
+    int crossfadeLength = max (1, (int) processorInfo.blockSize);
+    int lookaheadLength = processorInfo.latencyInSamples + processorInfo.blockSize;
+    int warmUpLength    = lookaheadLength + (int) (warmUpInSeconds * sampleRate);
+
+    // Segments shorter than the overlap give no speedup
+    int numOfSegments = max (1, min (numOfJobs, numOfSamplesInSource / (warmUpLength + crossfadeLength)));
+    vector<int> segmentBoundaries (numOfSegments + 1);
+    for (int segmentIndex = 0; segmentIndex <= numOfSegments; segmentIndex++)
+        segmentBoundaries[segmentIndex] = (int) ((int64_t) numOfSamplesInSource * segmentIndex / numOfSegments);
+
+    cout << "Processing " << numOfSegments << " segments in parallel." << endl;
+
+    // Each segment output covers its own range plus the crossfade into it
+    vector<int> outputStarts (numOfSegments);
+    vector<vector<float>> segmentOutputs (numOfSegments);
+    vector<char> segmentSucceeded (numOfSegments, 0);
+    vector<thread> segmentThreads;
+
+    for (int segmentIndex = 0; segmentIndex < numOfSegments; segmentIndex++) {
+        int outputStart = (segmentIndex == 0) ? 0 : max (0, segmentBoundaries[segmentIndex] - crossfadeLength);
+        int inputStart  = (segmentIndex == 0) ? 0 : max (0, outputStart - warmUpLength);
+        int segmentEnd  = segmentBoundaries[segmentIndex + 1];
+        int inputEnd    = min (numOfSamplesInSource, segmentEnd + lookaheadLength);
+
+        outputStarts[segmentIndex] = outputStart;
+        segmentOutputs[segmentIndex].resize (numOfChannels * (segmentEnd - outputStart));
+
+        segmentThreads.push_back (thread ([=, &inputAudio, &segmentOutputs, &segmentSucceeded] {
+            segmentSucceeded[segmentIndex] = processSegment (modelFilePath, inputAudio.data() + numOfChannels * inputStart,
+                                                             inputEnd - inputStart, segmentEnd - inputStart, numOfChannels, sampleRate,
+                                                             outputStart - inputStart, segmentOutputs[segmentIndex].data());
+        }));
+    }
+
+    for (auto& segmentThread : segmentThreads)
+        segmentThread.join();
+
+    for (int segmentIndex = 0; segmentIndex < numOfSegments; segmentIndex++) {
+        if (!segmentSucceeded[segmentIndex])
+            handleError ("Unable to process audio with the HANCE audio processor.");
+    }
+
+    // Stitch the segments together with a linear crossfade
+    vector<float> outputAudio (numOfChannels * numOfSamplesInSource);
+    for (int segmentIndex = 0; segmentIndex < numOfSegments; segmentIndex++) {
+        const float* segmentOutput  = segmentOutputs[segmentIndex].data();
+        int crossfadeEnd            = (segmentIndex == 0) ? 0 : segmentBoundaries[segmentIndex];
+        int numOfCrossfadeSamples   = crossfadeEnd - outputStarts[segmentIndex];
+
+        for (int sampleIndex = 0; sampleIndex < numOfCrossfadeSamples; sampleIndex++) {
+            float fadeIn = (sampleIndex + 0.5f) / numOfCrossfadeSamples;
+            float* outputFrame = outputAudio.data() + numOfChannels * (outputStarts[segmentIndex] + sampleIndex);
+            for (int channelIndex = 0; channelIndex < numOfChannels; channelIndex++)
+                outputFrame[channelIndex] = (1.f - fadeIn) * outputFrame[channelIndex] + fadeIn * segmentOutput[numOfChannels * sampleIndex + channelIndex];
+        }
+
+        memcpy (outputAudio.data() + numOfChannels * crossfadeEnd, segmentOutput + numOfChannels * numOfCrossfadeSamples,
+                numOfChannels * (segmentBoundaries[segmentIndex + 1] - crossfadeEnd) * sizeof (float));
+    }
+
+    if (!writeRiffAudio (g_outputFileHandle, outputAudio.data(), (int32_t) outputAudio.size()))
+        handleError ("Unable to write audio to the output file.");
+}
+
 int main (int argc, char* argv[])
 {
-    // Parse the input arguments
-    if (argc < 4) {
+    // Parse the input arguments. The optional --jobs=N flag enables parallel processing of the
+    // whole file in N overlapping segments, and the optional --warmup=SECONDS flag sets the
+    // warm-up overlap of each segment beyond the model lookahead (2 seconds by default).
+    vector<char*> arguments;
+    int numOfJobs          = 1;
+    double warmUpInSeconds = 2.0;
+    for (int argumentIndex = 1; argumentIndex < argc; argumentIndex++) {
+        if (strncmp (argv[argumentIndex], "--jobs=", 7) == 0)
+            numOfJobs = max (1, atoi (argv[argumentIndex] + 7));
+        else if (strncmp (argv[argumentIndex], "--warmup=", 9) == 0)
+            warmUpInSeconds = max (0.0, atof (argv[argumentIndex] + 9));
+        else
+            arguments.push_back (argv[argumentIndex]);
+    }
+
+    if (arguments.size() < 3 || arguments.size() > 4) {
         cout << "Incorrect number of arguments." << endl
-             << "Usage: ProcessFile [model filepath] [input filepath] [output filepath] [license key (optional)]" << endl;
+             << "Usage: ProcessFile [model filepath] [input filepath] [output filepath] [license key (optional)] [--jobs=N (optional)] [--warmup=SECONDS (optional)]" << endl;
         return -1;
     }
-    char* modelFilePath  = argv[1];
-    char* inputFilePath  = argv[2];
-    char* outputFilePath = argv[3];
+    char* modelFilePath  = arguments[0];
+    char* inputFilePath  = arguments[1];
+    char* outputFilePath = arguments[2];
 
-    if (argc == 5) {
-        if (!hanceAddLicense (argv[4]))
+    if (arguments.size() == 4) {
+        if (!hanceAddLicense (arguments[3]))
             handleError ("License key not accepted.");
     }
 
@@ -97,53 +279,44 @@ int main (int argc, char* argv[])
     cout << "Vector arithmetic wrapper: " << wrapperNameBuffer.data() << endl << endl;
 
     // Print output bus information
-    int numOfOutputBusses = hanceGetNumOfOutputBusses (g_processorHandle);
     cout << "Output busses:" << endl;
 
-    // Here's a set of output busses we'd like to include in the output. Other buses will
-    // be muted.
-    set<string> outputsToIsolate = { "Dialogue", "Speech", "Processed", "Voice", "Vocals", "Snare" };
-
     // Always show floating point values with two decimals
     cout << fixed << setprecision (2);
 
-    for (int busIndex = 0; busIndex < numOfOutputBusses; busIndex++) {
-        vector<char> nameBuffer (255, '\0');
-        hanceGetOutputBusName (g_processorHandle, busIndex, (char*) nameBuffer.data(), nameBuffer.size());
-        string outputBusName = nameBuffer.data();
-
-        // Set the gain parameters for this output, 1.0 if bus should be included in output, otherwise 0.0
-        if (outputsToIsolate.find (outputBusName) != outputsToIsolate.end())
-            hanceSetParameterValue (g_processorHandle, HANCE_PARAM_BUS_GAINS + busIndex, 1.f);
-        else
-            hanceSetParameterValue (g_processorHandle, HANCE_PARAM_BUS_GAINS + busIndex, 0.f);
+    configureOutputBusses (g_processorHandle, true);
+    cout << endl;
 
-        // Set the sensitivity in percent for this output
-        hanceSetParameterValue (g_processorHandle, HANCE_PARAM_BUS_SENSITIVITIES + busIndex, 0.f);
+    if (numOfJobs > 1) {
+        processInParallel (modelFilePath, numOfSamplesInSource, numOfChannels, sampleRate, processorInfo, numOfJobs, warmUpInSeconds);
+        cout << "Completed processing." << endl;
 
-        // Read back the parameter values for demonstration
-        float gain          = hanceGetParameterValue (g_processorHandle, HANCE_PARAM_BUS_GAINS + busIndex);
-        float sensitivity   = hanceGetParameterValue (g_processorHandle, HANCE_PARAM_BUS_SENSITIVITIES + busIndex);
+        fclose (g_inputFileHandle);
+        fclose (g_outputFileHandle);
+        hanceDeleteProcessor (g_processorHandle);
 
-    // Make sure that we display floating point values with two decimals
-        cout << busIndex << ": " << outputBusName << ", gain = " << gain
-             << " (linear scaling), sensitivity = " << sensitivity << " (%)" << endl;
+        return 0;
     }
-    cout << endl;
 
     // Start processing loop
     cout << "Starting processing:" << endl;
 
+    // All buffers are allocated up front, so the processing loop runs without heap allocations
     int numOfSamplesWritten              = 0;
     int numOfSamplesRead                 = 0;
     const int maxNumberOfSamplesInBuffer = 2048;
     vector<float> audioBuffer (numOfChannels * maxNumberOfSamplesInBuffer);
+    vector<float> processedBuffer (numOfChannels * maxNumberOfSamplesInBuffer);
+    bool audioBufferIsSilent = false;
 
     while (numOfSamplesWritten < numOfSamplesInSource) {
         int numOfSamplesInBuffer;
         if (numOfSamplesRead == numOfSamplesInSource) {
             numOfSamplesInBuffer = maxNumberOfSamplesInBuffer;
-            fill (audioBuffer.begin(), audioBuffer.end(), 0.f);
+            if (!audioBufferIsSilent) {
+                fill (audioBuffer.begin(), audioBuffer.end(), 0.f);
+                audioBufferIsSilent = true;
+            }
         }
         else {
             numOfSamplesInBuffer = min (maxNumberOfSamplesInBuffer, numOfSamplesInSource - numOfSamplesRead);
@@ -161,16 +334,18 @@ int main (int argc, char* argv[])
         // Now, we check how many samples that are ready for pick-up
         int numOfSamplesToWrite = min (hanceGetNumOfPendingSamples (g_processorHandle), numOfSamplesInSource - numOfSamplesWritten);
 
-        // Fetch and save the audio to file if there's anything ready
-        if (numOfSamplesToWrite > 0) {
-            vector<float> processedBuffer (numOfChannels * numOfSamplesToWrite);
-            if (!hanceGetAudioInterleaved (g_processorHandle, processedBuffer.data(), numOfSamplesToWrite))
+        // Fetch and save the audio to file if there's anything ready. The block based processing may
+        // release more samples than we added, so we fetch them in chunks that fit the buffer.
+        while (numOfSamplesToWrite > 0) {
+            int numOfSamplesInChunk = min (numOfSamplesToWrite, maxNumberOfSamplesInBuffer);
+            if (!hanceGetAudioInterleaved (g_processorHandle, processedBuffer.data(), numOfSamplesInChunk))
                 handleError ("Unable to get audio from the HANCE audio processor.");
 
             // Write audio to file
-            if (!writeRiffAudio (g_outputFileHandle, processedBuffer.data(), (int32_t) processedBuffer.size()))
+            if (!writeRiffAudio (g_outputFileHandle, processedBuffer.data(), numOfChannels * numOfSamplesInChunk))
                 handleError ("Unable to write audio to the output file.");
-            numOfSamplesWritten += numOfSamplesToWrite;
+            numOfSamplesWritten += numOfSamplesInChunk;
+            numOfSamplesToWrite -= numOfSamplesInChunk;
         }
         cout << ".";
     }
@@ -15,6 +15,12 @@ a written permission from HANCE AS.
 
 using namespace std;
 
+// Number of values converted per chunk when reading or writing audio data
+static const int numOfValuesPerChunk = 1024;
+
+// 1 / 32768 is exact in floating point, so the multiplication gives the same result as a division
+static const float int16ToFloatScale = 1.f / 32768.f;
+
 int getRiffSpecifier (string tag)
 {
     if (tag.size() < 4)
@@ -92,18 +98,23 @@ bool parseRiffHeader (FILE* fileHandle, int& numOfSamplesInSource, int& numOfCha
 
 bool readRiffAudio (FILE* fileHandle, float* audioData, int numOfValuesToRead)
 {
-    // We only support 16 bit files for simplicity
-    vector<int16_t> intBuffer (numOfValuesToRead);
+    // We only support 16 bit files for simplicity. The integer data is read and converted
+    // in chunks that stay in the L1 cache, so no intermediate heap buffer is needed
+    int16_t intBuffer[numOfValuesPerChunk];
 
-    // Read integer data
-    auto numOfValuesRead = fread (intBuffer.data(), sizeof (int16_t), numOfValuesToRead, fileHandle);
-    if (numOfValuesRead != numOfValuesToRead)
-        return false;
+    for (int chunkOffset = 0; chunkOffset < numOfValuesToRead; chunkOffset += numOfValuesPerChunk) {
+        int numOfValuesInChunk = min (numOfValuesPerChunk, numOfValuesToRead - chunkOffset);
 
-    // Convert to floating point
-    auto intBufferPtr = intBuffer.data();
-    for (int valueIndex = 0; valueIndex < numOfValuesToRead; valueIndex++)
-        audioData[valueIndex] = intBufferPtr[valueIndex] / 32768.f;
+        // Read integer data
+        auto numOfValuesRead = fread (intBuffer, sizeof (int16_t), numOfValuesInChunk, fileHandle);
+        if (numOfValuesRead != numOfValuesInChunk)
+            return false;
+
+        // Convert to floating point
+        auto audioDataPtr = audioData + chunkOffset;
+        for (int valueIndex = 0; valueIndex < numOfValuesInChunk; valueIndex++)
+            audioDataPtr[valueIndex] = intBuffer[valueIndex] * int16ToFloatScale;
+    }
 
     return true;
 }
@@ -153,17 +164,21 @@ bool writeRiffHeader (FILE* fileHandle, int numOfSamplesToWrite, int numOfChanne
 bool writeRiffAudio (FILE* fileHandle, const float* audioData, int numOfValuesToWrite)
 {
     // We only support 16 bit files for simplicity
-    vector<int16_t> intBuffer (numOfValuesToWrite);
+    int16_t intBuffer[numOfValuesPerChunk];
 
-    // Convert from floating point
-    auto intBufferPtr = intBuffer.data();
-    for (int valueIndex = 0; valueIndex < numOfValuesToWrite; valueIndex++)
-        intBufferPtr[valueIndex] = (int16_t) (max (min (audioData[valueIndex] * 32768.f + 0.5f, 32767.f), -32768.f));
+    for (int chunkOffset = 0; chunkOffset < numOfValuesToWrite; chunkOffset += numOfValuesPerChunk) {
+        int numOfValuesInChunk = min (numOfValuesPerChunk, numOfValuesToWrite - chunkOffset);
 
-    // Read integer data
-    auto numOfValuesWritten = fwrite (intBuffer.data(), sizeof (int16_t), numOfValuesToWrite, fileHandle);
-    if (numOfValuesWritten != numOfValuesToWrite)
-        return false;
+        // Convert from floating point
+        auto audioDataPtr = audioData + chunkOffset;
+        for (int valueIndex = 0; valueIndex < numOfValuesInChunk; valueIndex++)
+            intBuffer[valueIndex] = (int16_t) (max (min (audioDataPtr[valueIndex] * 32768.f + 0.5f, 32767.f), -32768.f));
+
+        // Write integer data
+        auto numOfValuesWritten = fwrite (intBuffer, sizeof (int16_t), numOfValuesInChunk, fileHandle);
+        if (numOfValuesWritten != numOfValuesInChunk)
+            return false;
+    }
 
     return true;
 }
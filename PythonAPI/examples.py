@@ -76,6 +76,7 @@ def main():
 
     # Initialize HanceEngine and create processor
     hance_engine = hance.HanceEngine()
+    print("Vector arithmetic wrapper:", hance_engine.get_vector_arithmetic_wrapper_name())
     # Here we might need to know the number of channels and sample rate
     # Let's assume stereo and 44100 Hz
     processor = hance_engine.create_processor(selected_model, 2, 44100)
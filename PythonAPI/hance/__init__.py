@@ -3,5 +3,5 @@ from .hance import (
     list_models,
     update_models,
 )
-from .hance_file import process_file  # Makes process_file available when importing the module
+from .hance_file import process_buffer, process_file  # Makes process_buffer and process_file available when importing the module
 from .version import __version__  # Makes __version__ available when importing the module
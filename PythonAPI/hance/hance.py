@@ -58,6 +58,11 @@ class HanceEngine:
                 raise Exception("Unable to load HANCE model file.")
             self.num_of_channels = num_of_channels
 
+            processor_info = ProcessorInfo()
+            self.hance_engine.hanceGetProcessorInfo(self.handle, ctypes.byref(processor_info))
+            self.latency_in_samples = processor_info.latencyInSamples
+            self.num_of_latency_samples_remaining = self.latency_in_samples
+
         def __del__(self):
             self.hance_engine.hanceDeleteProcessor(self.handle)
 
@@ -67,7 +72,7 @@ class HanceEngine:
             will normally differ from the input lengt due to latency and block based processing.
             """
             num_of_input_samples = audio_signal.shape[0]
-            interleaved_audio = audio_signal.astype(np.float32).flatten()
+            interleaved_audio = np.ascontiguousarray(audio_signal, dtype=np.float32)
             self.hance_engine.hanceAddAudioInterleaved(
                 self.handle,
                 interleaved_audio.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
@@ -75,20 +80,64 @@ class HanceEngine:
             )
             num_of_output_samples = self.hance_engine.hanceGetNumOfPendingSamples(self.handle)
             if num_of_output_samples > 0:
-                num_of_output_elements = self.num_of_channels * num_of_output_samples
-                PCMArray = ctypes.c_float * num_of_output_elements
-                pcm_out = PCMArray(*range(num_of_output_elements))
+                # The engine writes the processed audio straight into the array we return
+                pcm_out = np.empty((num_of_output_samples, self.num_of_channels), dtype=np.float32)
                 self.hance_engine.hanceGetAudioInterleaved(
                     self.handle,
-                    ctypes.cast(pcm_out, ctypes.POINTER(ctypes.c_float)),
+                    pcm_out.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
                     num_of_output_samples,
                 )
-                return np.array(pcm_out).reshape(num_of_output_samples, self.num_of_channels)
+                return pcm_out
             else:
                 return np.empty((0, 0))
 
+        def process_in_place(self, audio_signal: np.ndarray):
+            """
+            Processes audio in a C-contiguous float32 numpy array with the format [samples, channels] and overwrites
+            it with the processed audio. The output always has the same length as the input and is delayed by exactly
+            latencyInSamples, so no intermediate buffers or pending sample bookkeeping are needed in the caller.
+
+            The method never raises once the input is accepted: should the engine have fewer samples ready than
+            expected, the shortfall is output as silence and the delay grows by the same number of samples.
+            Don't mix process and process_in_place on the same processor without calling reset in between, as
+            process consumes samples that the fixed-latency accounting expects to be pending.
+            """
+            if (
+                audio_signal.dtype != np.float32
+                or audio_signal.ndim != 2
+                or audio_signal.shape[1] != self.num_of_channels
+                or not audio_signal.flags["C_CONTIGUOUS"]
+            ):
+                raise ValueError("Audio must be a C-contiguous float32 array with the format [samples, channels].")
+
+            num_of_samples = audio_signal.shape[0]
+            self.hance_engine.hanceAddAudioInterleaved(
+                self.handle,
+                audio_signal.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+                num_of_samples,
+            )
+
+            # The first latencyInSamples output samples are silent, the rest is fetched from the engine
+            num_of_silent_samples = min(self.num_of_latency_samples_remaining, num_of_samples)
+            self.num_of_latency_samples_remaining -= num_of_silent_samples
+            num_of_processed_samples = min(
+                num_of_samples - num_of_silent_samples,
+                max(0, self.hance_engine.hanceGetNumOfPendingSamples(self.handle)),
+            )
+
+            # Any shortfall is left pending in the engine and output as extra silence before the processed audio
+            num_of_silent_samples = num_of_samples - num_of_processed_samples
+            if num_of_processed_samples > 0:
+                self.hance_engine.hanceGetAudioInterleaved(
+                    self.handle,
+                    audio_signal[num_of_silent_samples:].ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+                    num_of_processed_samples,
+                )
+            audio_signal[:num_of_silent_samples] = 0.0
+
         def reset(self):
-            self.hance_engine.hanceResetProcessor()
+            self.hance_engine.hanceResetProcessorState(self.handle)
+            self.num_of_latency_samples_remaining = self.latency_in_samples
 
         def get_info(self):
             """
@@ -313,6 +362,12 @@ class HanceEngine:
         ]
         self.hance_engine.hanceGetParameterRange.restype = None  # void function
 
+        # HANCE_API void hanceGetVectorArithmeticWrapperName (char* wrapperName, int32_t maxLength);
+        self.hance_engine.hanceGetVectorArithmeticWrapperName.argtypes = [
+            ctypes.POINTER(ctypes.c_char),  # char* wrapperName
+            ctypes.c_int32                  # int32_t maxLength
+        ]
+        self.hance_engine.hanceGetVectorArithmeticWrapperName.restype = None  # void function
 
         self.prev_samplerate = None
         self.prev_channels = None
@@ -320,6 +375,14 @@ class HanceEngine:
     def add_license(self, license_string: str) -> bool:
         return self.hance_engine.hanceAddLicense(license_string.encode())
 
+    def get_vector_arithmetic_wrapper_name(self, max_length=256) -> str:
+        """
+        Returns the name of the vector arithmetic library used by the loaded HANCE Engine binary.
+        """
+        wrapper_name = (ctypes.c_char * max_length)()
+        self.hance_engine.hanceGetVectorArithmeticWrapperName(wrapper_name, max_length)
+        return wrapper_name.value.decode('utf-8')
+
     def create_processor(
         self, model_file_path: str, num_of_channels: int, sample_rate: int
     ) -> Processor:
@@ -346,7 +409,11 @@ class HanceEngine:
             fn = self.find_preferred_dylib(os.path.join(relative_path, "macOS"), "libHanceEngine")
             path_to_binary = os.path.join(relative_path, "macOS", fn)
         elif platform.system() == "Linux":
-            path_to_binary = os.path.join(relative_path, "Linux_x64/libHanceEngine.so")
+            # Pick the binary matching the host CPU at runtime, so ARM64 hosts get the NEON build
+            if platform.machine().lower() in ("aarch64", "arm64"):
+                path_to_binary = os.path.join(relative_path, "Linux_arm64/libHanceEngine.so")
+            else:
+                path_to_binary = os.path.join(relative_path, "Linux_x64/libHanceEngine.so")
 
         return path_to_binary
     
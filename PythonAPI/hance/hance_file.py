@@ -1,5 +1,9 @@
 import os
+import queue
+from concurrent.futures import ThreadPoolExecutor
+import shutil
 import subprocess
+import threading
 import numpy as np
 import hance
 
@@ -10,17 +14,258 @@ except ImportError:
     print("pip install soundfile")
     exit()
 
-def process_file(
-    model_file_path: str, input_file_path: str, output_file_path: str, license_string: str = "", selected_output_bus: int = 0
-):
+# Number of decoded or processed blocks that may be queued between the I/O threads and inference
+IO_QUEUE_DEPTH = 4
+
+
+def decode_blocks_in_background(input_file_path: str, block_size: int):
+    """
+    Decodes the input file on a worker thread and yields the blocks in order, so that decoding
+    overlaps with inference. Closing the generator stops the worker thread and closes the file.
+    """
+    block_queue = queue.Queue(maxsize=IO_QUEUE_DEPTH)
+    stop_decoding = threading.Event()
+
+    def put(item) -> bool:
+        # Waits for room in the queue unless the consumer has stopped decoding
+        while not stop_decoding.is_set():
+            try:
+                block_queue.put(item, timeout=0.1)
+                return True
+            except queue.Full:
+                pass
+        return False
+
+    def decode():
+        try:
+            with sf.SoundFile(input_file_path) as input_file:
+                for audio_block in input_file.blocks(dtype="float32", blocksize=block_size, always_2d=True):
+                    if not put(audio_block):
+                        return
+            put(None)
+        except Exception as exception:
+            put(exception)
+
+    decoder_thread = threading.Thread(target=decode, daemon=True)
+    decoder_thread.start()
+
+    try:
+        while True:
+            audio_block = block_queue.get()
+            if audio_block is None:
+                return
+            if isinstance(audio_block, Exception):
+                raise audio_block
+            yield audio_block
+    finally:
+        stop_decoding.set()
+        decoder_thread.join()
+
+
+class BackgroundWriter:
     """
-    Processes a full wave file using the preloaded model
+    Encodes and writes processed blocks to a SoundFile on a worker thread, so that encoding
+    overlaps with inference
+    """
+
+    def __init__(self, output_file):
+        self.output_file = output_file
+        self.block_queue = queue.Queue(maxsize=IO_QUEUE_DEPTH)
+        self.exception = None
+        self.thread = threading.Thread(target=self.encode, daemon=True)
+        self.thread.start()
+
+    def encode(self):
+        while True:
+            audio_block = self.block_queue.get()
+            if audio_block is None:
+                return
+            if self.exception is None:
+                try:
+                    self.output_file.write(audio_block)
+                except Exception as exception:
+                    self.exception = exception
+
+    def write(self, audio_block):
+        if self.exception is not None:
+            raise self.exception
+        self.block_queue.put(audio_block)
+
+    def close(self, raise_exception: bool = True):
+        self.block_queue.put(None)
+        self.thread.join()
+        self.output_file.close()
+        if raise_exception and self.exception is not None:
+            raise self.exception
+
+
+def select_output_bus(processor, selected_output_bus: int):
+    """
+    Mutes all output buses except the selected one and sets neutral sensitivities
+    """
+    for i in range(processor.get_number_of_output_buses()):
+        processor.set_output_bus_sensitivity(i, 0.0)
+        if i == selected_output_bus:
+            processor.set_output_bus_volume(i, 1.0)
+        else:
+            processor.set_output_bus_volume(i, 0.0)
+
+
+def process_segment(
+    processor, audio_signal: np.ndarray, num_of_samples_to_skip: int, num_of_samples_to_keep: int
+) -> np.ndarray:
+    """
+    Processes a segment of audio in the format [samples, channels] from a freshly created processor and
+    returns num_of_samples_to_keep output samples aligned with the input, omitting the first
+    num_of_samples_to_skip samples. Input beyond the kept range is only used as lookahead, and the
+    processing tail is flushed with silence only when the segment doesn't cover it.
+    """
+    num_of_samples = num_of_samples_to_skip + num_of_samples_to_keep
+    audio_out = np.empty([num_of_samples, audio_signal.shape[1]], dtype=np.float32)
+    num_of_samples_written = 0
+
+    processed = processor.process(audio_signal)
+    if processed.size != 0:
+        num_of_samples_written = min(processed.shape[0], num_of_samples)
+        audio_out[:num_of_samples_written] = processed[:num_of_samples_written]
+
+    # Process remaining samples by feeding silence to the processor
+    silent_audio = np.zeros([max(1, num_of_samples - num_of_samples_written), audio_signal.shape[1]], dtype="float32")
+    while num_of_samples_written < num_of_samples:
+        remaining_samples = num_of_samples - num_of_samples_written
+        processed = processor.process(silent_audio[:remaining_samples])
+        if processed.size != 0:
+            num_of_samples_to_copy = min(processed.shape[0], remaining_samples)
+            audio_out[num_of_samples_written : num_of_samples_written + num_of_samples_to_copy] = processed[
+                :num_of_samples_to_copy
+            ]
+            num_of_samples_written += num_of_samples_to_copy
+
+    return audio_out[num_of_samples_to_skip:]
+
+
+def process_buffer(
+    model_file_path: str,
+    audio_signal: np.ndarray,
+    sample_rate: float,
+    license_string: str = "",
+    selected_output_bus: int = 0,
+    num_of_workers: int = None,
+    warm_up_in_seconds: float = 2.0,
+) -> np.ndarray:
+    """
+    Processes a complete buffer in the format [samples, channels] and returns the processed audio with the
+    same length and alignment as the input.
+
+    The buffer is split into num_of_workers segments (defaults to the number of CPU cores) that are processed
+    in parallel, each on its own processor. Every segment except the first starts early by a warm-up overlap of
+    latencyInSamples + blockSize + warm_up_in_seconds * sample_rate samples, and every segment except the last
+    reads latencyInSamples + blockSize samples past its end as lookahead, so the processing tail is only flushed
+    with silence at the end of the buffer. Neighbouring segments are crossfaded linearly over blockSize samples.
+
+    The output equals sequential processing up to floating point rounding, crossfades included, when the model
+    output depends on at most warm_up_length = latencyInSamples + blockSize + warm_up_in_seconds * sample_rate
+    past input samples. Models with recurrent state have no such hard limit, so no bound is guaranteed for
+    them; increase warm_up_in_seconds until the difference is acceptable for your material.
     """
     hance_engine = hance.HanceEngine()
     if license_string:
         if not hance_engine.add_license(license_string):
             raise Exception("License key not accepted")
 
+    audio_signal = np.ascontiguousarray(audio_signal, dtype=np.float32)
+    num_of_samples, num_of_channels = audio_signal.shape
+
+    processor = hance_engine.create_processor(model_file_path, num_of_channels, sample_rate)
+    processor_info = processor.get_info()
+    crossfade_length = max(1, processor_info["blockSize"])
+    lookahead_length = processor_info["latencyInSamples"] + processor_info["blockSize"]
+    warm_up_length = lookahead_length + int(warm_up_in_seconds * sample_rate)
+
+    if num_of_workers is None:
+        num_of_workers = os.cpu_count() or 1
+
+    # Segments shorter than the overlap give no speedup, so we reduce the number of segments for short buffers
+    num_of_segments = max(1, min(num_of_workers, num_of_samples // (warm_up_length + crossfade_length)))
+    segment_boundaries = [num_of_samples * i // num_of_segments for i in range(num_of_segments + 1)]
+
+    def process_segment_with_overlap(segment_index: int) -> np.ndarray:
+        # Each segment covers its own range plus the crossfade into it, preceded by the warm-up overlap
+        # and followed by the lookahead the model needs to compute the last samples of the range
+        output_start = max(0, segment_boundaries[segment_index] - crossfade_length)
+        input_start = max(0, output_start - warm_up_length)
+        if segment_index == 0:
+            output_start = input_start = 0
+        output_end = segment_boundaries[segment_index + 1]
+        input_end = min(num_of_samples, output_end + lookahead_length)
+
+        segment_processor = (
+            processor
+            if segment_index == 0
+            else hance_engine.create_processor(model_file_path, num_of_channels, sample_rate)
+        )
+        select_output_bus(segment_processor, selected_output_bus)
+        return process_segment(
+            segment_processor,
+            audio_signal[input_start:input_end],
+            output_start - input_start,
+            output_end - output_start,
+        )
+
+    # The HANCE engine releases the GIL while processing, so the segments run concurrently
+    with ThreadPoolExecutor(max_workers=num_of_segments) as executor:
+        segment_outputs = list(executor.map(process_segment_with_overlap, range(num_of_segments)))
+
+    audio_out = segment_outputs[0]
+    if num_of_segments > 1:
+        audio_out = np.empty_like(audio_signal)
+        audio_out[: segment_boundaries[1]] = segment_outputs[0]
+        for segment_index in range(1, num_of_segments):
+            # Every segment output starts with the crossfade into the previous segment
+            segment_output = segment_outputs[segment_index]
+            crossfade_end = segment_boundaries[segment_index]
+            crossfade_start = crossfade_end - min(crossfade_length, crossfade_end)
+            num_of_crossfade_samples = crossfade_end - crossfade_start
+            fade_in = ((np.arange(num_of_crossfade_samples, dtype=np.float32) + 0.5) / num_of_crossfade_samples)[
+                :, np.newaxis
+            ]
+            audio_out[crossfade_start:crossfade_end] *= 1.0 - fade_in
+            audio_out[crossfade_start:crossfade_end] += fade_in * segment_output[:num_of_crossfade_samples]
+            audio_out[crossfade_end : segment_boundaries[segment_index + 1]] = segment_output[num_of_crossfade_samples:]
+
+    return audio_out
+
+
+def open_output_file(output_file_path: str, in_file_info):
+    """
+    Opens the output file for writing with the same format as the input file
+    """
+    return sf.SoundFile(
+        output_file_path,
+        mode="w",
+        samplerate=in_file_info.samplerate,
+        channels=in_file_info.channels,
+        subtype=in_file_info.subtype,
+        endian=in_file_info.endian,
+        format=in_file_info.format,
+    )
+
+
+def process_file(
+    model_file_path: str,
+    input_file_path: str,
+    output_file_path: str,
+    license_string: str = "",
+    selected_output_bus: int = 0,
+    num_of_workers: int = 1,
+    warm_up_in_seconds: float = 2.0,
+):
+    """
+    Processes a full wave file using the preloaded model. With num_of_workers above one, the whole file is
+    loaded into memory and processed in overlapping segments in parallel, see process_buffer for the meaning
+    of warm_up_in_seconds. The output file is only opened once the model is loaded, so an existing output
+    file is left untouched if the model can't be loaded.
+    """
     created_temp_file = False
     try:
         in_file_info = sf.SoundFile(input_file_path)
@@ -37,50 +282,81 @@ def process_file(
         in_file_info = sf.SoundFile(input_file_path)
         created_temp_file = True
 
-    processor = hance_engine.create_processor(
-        model_file_path, in_file_info.channels, in_file_info.samplerate
-    )
-
-    for i in range(processor.get_number_of_output_buses()):
-        processor.set_output_bus_sensitivity(i, 0.0)
-        if i == selected_output_bus:
-            processor.set_output_bus_volume(i, 1.0)
+    try:
+        if num_of_workers > 1:
+            audio_out = process_buffer(
+                model_file_path,
+                in_file_info.read(dtype="float32", always_2d=True),
+                in_file_info.samplerate,
+                license_string,
+                selected_output_bus,
+                num_of_workers,
+                warm_up_in_seconds,
+            )
+            with open_output_file(output_file_path, in_file_info) as output_file:
+                output_file.write(audio_out)
         else:
-            processor.set_output_bus_volume(i, 0.0)
-        
+            process_file_streaming(
+                model_file_path, input_file_path, output_file_path, in_file_info, license_string, selected_output_bus
+            )
+    finally:
+        in_file_info.close()
+        if created_temp_file:
+            os.remove(input_file_path)
 
-    output_file = sf.SoundFile(
-        output_file_path,
-        mode="w",
-        samplerate=in_file_info.samplerate,
-        channels=in_file_info.channels,
-        subtype=in_file_info.subtype,
-        endian=in_file_info.endian,
-        format=in_file_info.format,
+
+def process_file_streaming(
+    model_file_path: str,
+    input_file_path: str,
+    output_file_path: str,
+    in_file_info,
+    license_string: str,
+    selected_output_bus: int,
+):
+    """
+    Processes a full wave file block by block on a single processor
+    """
+    hance_engine = hance.HanceEngine()
+    if license_string:
+        if not hance_engine.add_license(license_string):
+            raise Exception("License key not accepted")
+
+    processor = hance_engine.create_processor(
+        model_file_path, in_file_info.channels, in_file_info.samplerate
     )
+    select_output_bus(processor, selected_output_bus)
 
     block_size = 65536
     num_of_samples_written = 0
-    num_of_samples = len(in_file_info) // in_file_info.channels
+    num_of_samples = in_file_info.frames
 
-    for audio_block in sf.blocks(
-        input_file_path, dtype="float32", blocksize=block_size, always_2d=True
-    ):
-        audio_out = processor.process(audio_block)
-        if audio_out.size != 0:
-            output_file.write(audio_out)
-            num_of_samples_written += audio_out.shape[0]
+    # The HANCE engine releases the GIL while processing, so decoding, inference and encoding
+    # run concurrently on separate threads
+    output_file = BackgroundWriter(open_output_file(output_file_path, in_file_info))
+    audio_blocks = decode_blocks_in_background(input_file_path, block_size)
 
-    # Process remaining samples by feeding silence to the processor
-    silent_audio = np.zeros([block_size, in_file_info.channels], dtype="float32")
-    while num_of_samples_written < num_of_samples:
-        remaining_samples = num_of_samples - num_of_samples_written
-        samples_to_process = min(block_size, remaining_samples)
-        audio_out = processor.process(silent_audio[:samples_to_process])
-        if audio_out.size != 0:
-            output_file.write(audio_out)
-            num_of_samples_written += audio_out.shape[0]
+    # The I/O threads and file handles are released even if processing fails
+    try:
+        for audio_block in audio_blocks:
+            audio_out = processor.process(audio_block)
+            if audio_out.size != 0:
+                output_file.write(audio_out)
+                num_of_samples_written += audio_out.shape[0]
+
+        # Process remaining samples by feeding silence to the processor
+        silent_audio = np.zeros([block_size, in_file_info.channels], dtype="float32")
+        while num_of_samples_written < num_of_samples:
+            remaining_samples = num_of_samples - num_of_samples_written
+            samples_to_process = min(block_size, remaining_samples)
+            audio_out = processor.process(silent_audio[:samples_to_process])
+            if audio_out.size != 0:
+                audio_out = audio_out[:remaining_samples]
+                output_file.write(audio_out)
+                num_of_samples_written += audio_out.shape[0]
+    except BaseException:
+        output_file.close(raise_exception=False)
+        raise
+    finally:
+        audio_blocks.close()
 
     output_file.close()
-    if created_temp_file:
-        os.remove(input_file_path)